@@ -0,0 +1,161 @@
+// ==========================================================================
+// Implementation: tearing down large pointer-owned trees.
+// Compares wall time and the longest pause of the default recursive destruction,
+// dismantle(), parallel dismantle(), and incremental_dismantler.
+// Exits with 1 if the parallel dismantle() left the work to one worker,
+// or a shared node was taken apart while still shared.
+// g++ -std=c++17 -O2 -pthread "example5 - dismantle.cpp"
+// ==========================================================================
+
+#include <iostream>
+#include <chrono>
+#include <algorithm>
+#include <atomic>
+#include "smart_pointer_dismantle.hpp"
+
+struct node
+{
+	int value;
+	std::unique_ptr< node > left;
+	std::unique_ptr< node > right;
+};
+
+struct shared_node
+{
+	int value;
+	std::shared_ptr< shared_node > next;
+};
+
+// hands every owning child to sink.
+auto expand_node = []( node& n, auto&& sink )
+{
+	sink( n.left );
+	sink( n.right );
+};
+
+// counts the workers of a parallel dismantle that take part.
+std::atomic< std::size_t > participants{ 0 };
+
+auto expand_node_counted = []( node& n, auto&& sink )
+{
+	thread_local bool counted = false;
+	if ( !counted )
+	{
+		counted = true;
+		participants.fetch_add( 1 );
+	}
+
+	expand_node( n, sink );
+};
+
+std::unique_ptr< node > make_tree( int depth )
+{
+	if ( depth == 0 ) return nullptr;
+	return std::unique_ptr< node >{ new node{ depth, make_tree( depth - 1 ), make_tree( depth - 1 ) } };
+}
+
+// a degenerate tree, one node per level. the default destruction overflows the stack on it.
+std::unique_ptr< node > make_chain( std::size_t length )
+{
+	std::unique_ptr< node > head;
+	for ( std::size_t i = 0; i < length; ++i ) head.reset( new node{ static_cast< int >( i ), std::move( head ), nullptr } );
+	return head;
+}
+
+using clock_type = std::chrono::steady_clock;
+
+template < typename F >
+double measure_ms( F&& f )
+{
+	const auto begin = clock_type::now();
+	f();
+	return std::chrono::duration< double, std::milli >( clock_type::now() - begin ).count();
+}
+
+int main()
+{
+	bool ok = true;
+
+	constexpr int depth = 22;				// 4M nodes
+	constexpr std::size_t chain_length = 10'000'000;
+	const std::size_t threads = std::max( 2u, std::thread::hardware_concurrency() );
+
+	std::cout << "====================================================\n";
+	std::cout << "tear down a balanced tree of " << ( ( 1 << depth ) - 1 ) << " nodes\n";
+	std::cout << "wall time / longest pause in ms\n";
+	std::cout << "====================================================\n\n\n";
+
+	{
+		auto root = make_tree( depth );
+		const auto ms = measure_ms( [ & ] { root.reset(); } );
+		std::cout << "recursive destruction:     " << ms << " / " << ms << '\n';
+	}
+
+	{
+		auto root = make_tree( depth );
+		const auto ms = measure_ms( [ & ] { woon2::dismantle( root, expand_node ); } );
+		std::cout << "dismantle:                 " << ms << " / " << ms << '\n';
+	}
+
+	{
+		auto root = make_tree( depth );
+		const auto ms = measure_ms( [ & ] { woon2::dismantle( root, expand_node_counted, threads ); } );
+		std::cout << "dismantle, " << threads << " threads:      " << ms << " / " << ms
+			<< " (" << participants.load() << " workers took part)\n";
+
+		// the work must actually be shared, not left to the first worker that steals root.
+		if ( participants.load() < 2 ) ok = false;
+	}
+
+	{
+		auto root = make_tree( depth );
+		auto dismantler = woon2::make_incremental_dismantler( root, expand_node );
+
+		double total = 0.0, longest = 0.0;
+		std::size_t slices = 0;
+		while ( !dismantler.done() )
+		{
+			const auto ms = measure_ms( [ & ] { dismantler.step( std::chrono::milliseconds{ 1 } ); } );
+			total += ms;
+			longest = std::max( longest, ms );
+			++slices;
+		}
+
+		std::cout << "incremental, 1ms slices:   " << total << " / " << longest << " (" << slices << " slices)\n";
+	}
+
+	std::cout << "\n\n";
+	std::cout << "====================================================\n";
+	std::cout << "tear down a chain of " << chain_length << " nodes\n";
+	std::cout << "====================================================\n\n\n";
+
+	{
+		auto root = make_chain( chain_length );
+		const auto ms = measure_ms( [ & ] { woon2::dismantle( root, expand_node ); } );
+		std::cout << "dismantle:                 " << ms << " ms, no stack overflow\n";
+	}
+
+	std::cout << "\n\n";
+	std::cout << "====================================================\n";
+	std::cout << "shared nodes are only taken apart by their sole owner\n";
+	std::cout << "====================================================\n\n\n";
+
+	{
+		std::shared_ptr< shared_node > head;
+		for ( int i = 0; i < 1000; ++i ) head = std::make_shared< shared_node >( shared_node{ i, head } );
+
+		auto kept = head->next->next;		// someone else still uses the tail.
+		woon2::dismantle( head, []( shared_node& n, auto&& sink ) { sink( n.next ); } );
+
+		std::size_t tail_length = 0;
+		for ( auto p = kept.get(); p; p = p->next.get() ) ++tail_length;
+
+		std::cout << "head after dismantle: " << head.get() << '\n';
+		std::cout << "kept tail is intact:  " << tail_length << " nodes\n";
+
+		if ( head || tail_length != 998 ) ok = false;
+	}
+
+	if ( !ok ) std::cout << "\ndismantle doesn't work.\n";
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,126 @@
+// ==========================================================================
+// Implementation: auditing the size of pointer handles.
+// Register your pointer types below. The program prints a report of the
+// registered_types, and exits with 1 if any of them grows beyond a raw pointer.
+// Define STRICT_POINTER_AUDIT to fail the build instead.
+// wide_types only demonstrates what overhead looks like in the report,
+// it doesn't count toward the exit status.
+// ==========================================================================
+
+#include <iostream>
+#include <iomanip>
+#include <typeinfo>
+#include "smart_pointer_type_trait.hpp"
+
+struct free_delete
+{
+	void operator()( void* ptr ) const noexcept { std::free( ptr ); }
+};
+
+struct counting_delete
+{
+	void operator()( int* ptr ) noexcept { ++count; delete ptr; }
+	int count = 0;
+};
+
+void delete_int( int* ptr ) { delete ptr; }
+
+template < typename Ty >
+struct Uptr : std::unique_ptr< Ty > {};
+
+template < typename ... Ts >
+struct type_list {};
+
+// ======================================================================
+// **********************************************************************
+// registered types
+// **********************************************************************
+// ======================================================================
+using registered_types = type_list<
+	int*,
+	std::unique_ptr< int >,
+	std::unique_ptr< float[] >,
+	std::unique_ptr< void, free_delete >,
+	Uptr< double >,
+	decltype( woon2::make_unique_aligned< float[] >( 0 ) )
+	>;
+
+// **********************************************************************
+// ======================================================================
+
+// known to be wider than a raw pointer, for the demo.
+using wide_types = type_list<
+	std::unique_ptr< int, void( * )( int* ) >,
+	std::unique_ptr< int, counting_delete >,
+	std::unique_ptr< int, free_delete& >,
+	std::shared_ptr< int >,
+	std::shared_ptr< float[] >
+	>;
+
+template < typename ... Ts >
+constexpr bool check_zero_overhead( type_list< Ts... > )
+{
+	return woon2::assert_zero_overhead< Ts... >();
+}
+
+template < typename T >
+bool report_one( std::ostream& os )
+{
+	using overhead = woon2::ownership_overhead< T >;
+
+	os << std::setw( 8 ) << overhead::handle_size
+		<< std::setw( 10 ) << overhead::deleter_size
+		<< std::setw( 15 ) << ( overhead::has_control_block ? "yes" : "no" )
+		<< std::setw( 10 ) << overhead::overhead
+		<< "  " << typeid( T ).name() << '\n';
+
+	return woon2::is_zero_overhead_v< T >;
+}
+
+template < typename ... Ts >
+bool report( std::ostream& os, type_list< Ts... > )
+{
+	os << std::setw( 8 ) << "handle" << std::setw( 10 ) << "deleter" << std::setw( 15 ) << "control block"
+		<< std::setw( 10 ) << "overhead" << "  type\n";
+
+	bool all_zero = true;
+	using expand = int[];
+	( void )expand{ 0, ( all_zero &= report_one< Ts >( os ), 0 )... };
+	return all_zero;
+}
+
+int main()
+{
+	// test type traits ==============================================
+	static_assert( woon2::ownership_overhead< std::unique_ptr< int > >::handle_size == sizeof( int* ), "ownership_overhead doesn't work." );
+	static_assert( woon2::ownership_overhead< std::unique_ptr< int, void( * )( int* ) > >::deleter_size == sizeof( void( * )( int* ) ),
+		"ownership_overhead doesn't work." );
+	static_assert( woon2::ownership_overhead< const std::shared_ptr< int >& >::has_control_block, "ownership_overhead doesn't work." );
+	static_assert( woon2::ownership_overhead< std::shared_ptr< int > >::deleter_size == 0, "ownership_overhead doesn't work." );
+	static_assert( !woon2::is_zero_overhead_v< std::unique_ptr< int, counting_delete > >, "is_zero_overhead doesn't work." );
+	static_assert( woon2::ownership_overhead< std::unique_ptr< int, free_delete& > >::deleter_size == sizeof( void* ),
+		"ownership_overhead doesn't work. ( a reference deleter is stored as a pointer. )" );
+	static_assert( woon2::ownership_overhead< Uptr< int > >::deleter_size == 0, "ownership_overhead doesn't work." );
+#ifdef STRICT_POINTER_AUDIT
+	static_assert( check_zero_overhead( registered_types{} ), "registered_types must be as small as a raw pointer." );
+#endif
+	// ===============================================================
+
+	std::cout << "====================================================\n";
+	std::cout << "pointer audit, raw pointer is " << sizeof( void* ) << " bytes\n";
+	std::cout << "====================================================\n\n\n";
+
+	std::unique_ptr< int, void( * )( int* ) > p{ new int{ 3 }, delete_int };		// 16 bytes for one int*.
+	std::cout << "unique_ptr< int, void( * )( int* ) > is " << sizeof( p ) << " bytes\n\n";
+
+	std::cout << "registered types ===================================\n";
+	const bool all_zero = report( std::cout, registered_types{} );
+	std::cout << '\n' << ( all_zero ? "no overhead found.\n" : "some handles are bigger than a raw pointer.\n" );
+	std::cout << "====================================================\n\n\n";
+
+	std::cout << "wide types, for the demo ===========================\n";
+	report( std::cout, wide_types{} );
+	std::cout << "====================================================\n";
+
+	return all_zero ? 0 : 1;
+}
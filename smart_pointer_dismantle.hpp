@@ -0,0 +1,360 @@
+// ==========================================================================
+// Dismantle for pointer-owned structures
+// Dropping the root of a tree held by unique_ptr / shared_ptr children destroys it recursively,
+// one stack frame per level, on one thread.
+// dismantle( root, expand ) detaches the children into a worklist instead, so destruction is
+// iterative, can be spread over a work-stealing pool, or can be done in bounded time slices.
+// expand( node, sink ) must hand every owning child of node to sink( child ).
+// ==========================================================================
+
+#ifndef _smart_pointer_dismantle
+#define _smart_pointer_dismantle
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "smart_pointer_type_trait.hpp"
+
+namespace woon2
+{
+	namespace detail
+	{
+		// a shared node is only ours to take apart when nobody else shares it.
+		template < typename Ptr >
+		bool is_sole_owner( const Ptr& ptr, std::true_type /* shared */ ) noexcept
+		{
+			return ptr.use_count() == 1;
+		}
+
+		template < typename Ptr >
+		bool is_sole_owner( const Ptr&, std::false_type /* unique */ ) noexcept
+		{
+			return true;
+		}
+
+		template < typename Ptr >
+		void check_dismantlable()
+		{
+			static_assert( is_unique_ptr_soft_v< Ptr > || is_shared_ptr_soft_v< Ptr > || ( has_release_v< Ptr > && has_reset_v< Ptr > ),
+				"dismantle(): Ptr must own its pointee. ( unique_ptr, shared_ptr, or a pointer class with release() and reset() )" );
+			static_assert( !is_array_ptr_soft_v< Ptr >, "dismantle(): Ptr must own a single node, not an array." );
+			static_assert( std::is_default_constructible< Ptr >::value && std::is_move_constructible< Ptr >::value,
+				"dismantle(): Ptr must be default constructible and move constructible." );
+			static_assert( std::is_constructible< bool, Ptr >::value, "dismantle(): Ptr must be convertible to bool." );
+		}
+
+		// a moved-from pointer class isn't promised to be empty, so ptr is reset after the move.
+		template < typename Ptr >
+		Ptr take( Ptr& ptr )
+		{
+			Ptr ret{ std::move( ptr ) };
+			ptr.reset();
+			return ret;
+		}
+
+		// moves node's children out through sink. node itself is destroyed by its owner afterwards,
+		// and with no children left, that doesn't recurse.
+		template < typename Ptr, typename Expand, typename Sink >
+		void dismantle_node( Ptr& node, Expand& expand, Sink& sink )
+		{
+			if ( !static_cast< bool >( node ) ) return;
+
+			// dropping our reference won't destroy it, someone else still owns it.
+			if ( !is_sole_owner( node, is_shared_ptr_soft< Ptr >{} ) ) return;
+
+			expand( *node, sink );
+		}
+
+		template < typename Ptr >
+		class dismantle_queue
+		{
+		public:
+			// count is sequentially consistent with dismantle_pool::sleepers,
+			// so a push is either seen by a worker about to park, or the pusher sees it parking.
+			void push( Ptr&& ptr )
+			{
+				std::lock_guard< std::mutex > lock{ mtx };
+				items.push_back( std::move( ptr ) );
+				count.store( items.size() );
+			}
+
+			// the oldest node is the nearest to the root, the biggest piece of work.
+			bool steal( Ptr& out )
+			{
+				if ( count.load() == 0 ) return false;
+
+				std::lock_guard< std::mutex > lock{ mtx };
+				if ( items.empty() ) return false;
+
+				out = std::move( items.front() );
+				items.pop_front();
+				count.store( items.size() );
+				return true;
+			}
+
+			bool empty() const noexcept
+			{
+				return count.load() == 0;
+			}
+
+		private:
+			std::mutex mtx;
+			std::deque< Ptr > items;
+			std::atomic< std::size_t > count{ 0 };
+		};
+
+		// each worker takes apart its own nodes depth first from a private deque,
+		// and shares its oldest node whenever its public queue runs dry.
+		// a worker out of work spins briefly, then parks until a node is shared,
+		// so it doesn't take CPU from the workers that still have nodes.
+		// pending counts the queued nodes plus the busy workers. a steal turns a queued node
+		// into a busy worker without touching it, so it only reaches 0 when the structure is gone.
+		template < typename Ptr, typename Expand >
+		class dismantle_pool
+		{
+		public:
+			// failed steals before an idle worker parks.
+			static constexpr std::size_t spin_count = 64;
+
+			dismantle_pool( Expand& expand_fn, std::size_t threads )
+				: expand{ expand_fn }, queues( threads ), pending{ 1 }, sleepers{ 0 } {}
+
+			void run( Ptr&& root )
+			{
+				queues[ 0 ].push( std::move( root ) );		// pending starts at 1 for it.
+
+				std::vector< std::thread > workers;
+				workers.reserve( queues.size() - 1 );
+				for ( std::size_t id = 1; id < queues.size(); ++id ) workers.emplace_back( [ this, id ] { work( id ); } );
+
+				work( 0 );
+				for ( auto& worker : workers ) worker.join();
+			}
+
+		private:
+			void work( std::size_t id )
+			{
+				std::deque< Ptr > local;
+				auto sink = [ &local ]( Ptr& child )
+				{
+					if ( static_cast< bool >( child ) ) local.push_back( take( child ) );
+				};
+
+				while ( true )
+				{
+					Ptr node{};
+					for ( std::size_t attempt = 0; !steal( id, node ); ++attempt )
+					{
+						if ( pending.load() == 0 ) return;
+
+						if ( attempt < spin_count ) std::this_thread::yield();
+						else park();
+					}
+
+					// busy now, the stolen node's share of pending is ours.
+					local.push_back( std::move( node ) );
+					while ( !local.empty() )
+					{
+						{
+							Ptr next = std::move( local.back() );
+							local.pop_back();
+							dismantle_node( next, expand, sink );
+						}
+
+						if ( local.size() > 1 && queues[ id ].empty() )
+						{
+							pending.fetch_add( 1 );
+							queues[ id ].push( std::move( local.front() ) );
+							local.pop_front();
+							if ( sleepers.load() != 0 ) wake( false );
+						}
+					}
+
+					// out of work. the last busy worker with nothing queued ends the pool.
+					if ( pending.fetch_sub( 1 ) == 1 )
+					{
+						wake( true );
+						return;
+					}
+				}
+			}
+
+			bool steal( std::size_t id, Ptr& out )
+			{
+				for ( std::size_t i = 0; i < queues.size(); ++i )
+				{
+					if ( queues[ ( id + i ) % queues.size() ].steal( out ) ) return true;
+				}
+
+				return false;
+			}
+
+			void park()
+			{
+				std::unique_lock< std::mutex > lock{ park_mtx };
+				sleepers.fetch_add( 1 );
+				park_cv.wait( lock, [ this ] { return !all_empty() || pending.load() == 0; } );
+				sleepers.fetch_sub( 1 );
+			}
+
+			void wake( bool all )
+			{
+				std::lock_guard< std::mutex > lock{ park_mtx };
+				if ( all ) park_cv.notify_all();
+				else park_cv.notify_one();
+			}
+
+			bool all_empty() const noexcept
+			{
+				for ( const auto& queue : queues )
+				{
+					if ( !queue.empty() ) return false;
+				}
+
+				return true;
+			}
+
+			Expand& expand;
+			std::vector< dismantle_queue< Ptr > > queues;
+			std::atomic< std::size_t > pending;
+			std::atomic< std::size_t > sleepers;
+			std::mutex park_mtx;
+			std::condition_variable park_cv;
+		};
+
+		template < typename Ptr, typename Expand >
+		constexpr std::size_t dismantle_pool< Ptr, Expand >::spin_count;
+	}
+
+	// =======================================================================================
+	// dismantle
+	// takes root apart iteratively on the calling thread. root is left empty.
+	// =======================================================================================
+	template < typename Ptr, typename Expand >
+	void dismantle( Ptr& root, Expand expand )
+	{
+		detail::check_dismantlable< Ptr >();
+
+		std::vector< Ptr > work;
+		auto sink = [ &work ]( Ptr& child )
+		{
+			if ( static_cast< bool >( child ) ) work.push_back( detail::take( child ) );
+		};
+
+		work.push_back( detail::take( root ) );
+		while ( !work.empty() )
+		{
+			Ptr node = std::move( work.back() );
+			work.pop_back();
+			detail::dismantle_node( node, expand, sink );
+		}
+	}
+
+	// takes root apart on threads workers, the calling thread included.
+	// expand is called concurrently, so it must be thread-safe, and must not throw.
+	// a shared node reached by two workers at once may still be destroyed recursively by the last one.
+	template < typename Ptr, typename Expand >
+	void dismantle( Ptr& root, Expand expand, std::size_t threads )
+	{
+		detail::check_dismantlable< Ptr >();
+
+		if ( threads <= 1 ) return dismantle( root, std::move( expand ) );
+
+		detail::dismantle_pool< Ptr, Expand > pool{ expand, threads };
+		pool.run( detail::take( root ) );
+	}
+
+	// dismantle end =========================================================================
+
+	// =======================================================================================
+	// incremental_dismantler
+	// takes root apart a time slice at a time, e.g. once per frame, bounding each pause.
+	// whatever is left is taken apart when the dismantler is destroyed.
+	// =======================================================================================
+	template < typename Ptr, typename Expand >
+	class incremental_dismantler
+	{
+	public:
+		// how many nodes to take apart between clock reads.
+		static constexpr std::size_t check_interval = 64;
+
+		incremental_dismantler( Ptr& root, Expand expand_fn )
+			: expand{ std::move( expand_fn ) }
+		{
+			detail::check_dismantlable< Ptr >();
+			if ( static_cast< bool >( root ) ) work.push_back( detail::take( root ) );
+		}
+
+		incremental_dismantler( const incremental_dismantler& ) = delete;
+		incremental_dismantler& operator=( const incremental_dismantler& ) = delete;
+		incremental_dismantler( incremental_dismantler&& ) = default;
+		incremental_dismantler& operator=( incremental_dismantler&& ) = delete;
+
+		~incremental_dismantler() { finish(); }
+
+		// works for about budget, returns done().
+		template < typename Rep, typename Period >
+		bool step( std::chrono::duration< Rep, Period > budget )
+		{
+			const auto deadline = std::chrono::steady_clock::now() + budget;
+
+			while ( !work.empty() )
+			{
+				step_nodes( check_interval );
+				if ( std::chrono::steady_clock::now() >= deadline ) break;
+			}
+
+			return done();
+		}
+
+		// takes apart at most max_nodes nodes, returns done().
+		bool step_nodes( std::size_t max_nodes )
+		{
+			auto sink = [ this ]( Ptr& child )
+			{
+				if ( static_cast< bool >( child ) ) work.push_back( detail::take( child ) );
+			};
+
+			for ( std::size_t i = 0; i < max_nodes && !work.empty(); ++i )
+			{
+				Ptr node = std::move( work.back() );
+				work.pop_back();
+				detail::dismantle_node( node, expand, sink );
+			}
+
+			return done();
+		}
+
+		void finish()
+		{
+			while ( !step_nodes( check_interval ) ) {}
+		}
+
+		bool done() const noexcept { return work.empty(); }
+
+		// nodes detached but not taken apart yet.
+		std::size_t pending() const noexcept { return work.size(); }
+
+	private:
+		Expand expand;
+		std::vector< Ptr > work;
+	};
+
+	template < typename Ptr, typename Expand >
+	constexpr std::size_t incremental_dismantler< Ptr, Expand >::check_interval;
+
+	template < typename Ptr, typename Expand >
+	incremental_dismantler< Ptr, Expand > make_incremental_dismantler( Ptr& root, Expand expand )
+	{
+		return { root, std::move( expand ) };
+	}
+
+	// incremental_dismantler end ============================================================
+}
+
+#endif // _smart_pointer_dismantle
@@ -4,12 +4,22 @@
 // Usage is like std::is_pointer< T >.
 // Soft version type traits additionally evalute a derived class from a pointer as true.
 // Just write "soft" after a type_trait to detect inheritance too.
+// is_array_ptr< T > / array_element_t< T > distinguish unique_ptr< T[] >, shared_ptr< T[] >.
+// as_span( p, n ) views an owned array as woon2::aligned_span, make_unique_aligned< T[] > allocates one.
+// ownership_overhead< T > reports what a pointer costs over a raw pointer, assert_zero_overhead< Ts... >() enforces it.
 // ==========================================================================
 
 #ifndef _smart_pointer_type_trait
 #define _smart_pointer_type_trait
 
 #include <memory>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+#include <new>
+#include <type_traits>
 
 namespace woon2
 {
@@ -116,6 +126,62 @@ namespace woon2
 
 	// united type trait ( smart pointers ) end ==============================================
 
+	// =======================================================================================
+	// array pointer type trait
+	// unique_ptr< T[] > and shared_ptr< T[] > own a contiguous buffer, not a single object.
+	// is_unique_ptr, is_shared_ptr can't tell them apart, so use these to do it.
+	// =======================================================================================
+	namespace detail
+	{
+		template < typename T >
+		struct is_array_ptr_impl : std::false_type {};
+
+		template < typename T, typename Dx >
+		struct is_array_ptr_impl< std::unique_ptr< T[], Dx > > : std::true_type {};
+
+		template < typename T >
+		struct is_array_ptr_impl< std::shared_ptr< T[] > > : std::true_type {};
+
+		template < typename T, typename Dx >
+		std::true_type is_array_ptr_soft_impl( std::unique_ptr< T[], Dx >* );
+		template < typename T >
+		std::true_type is_array_ptr_soft_impl( std::shared_ptr< T[] >* );
+		std::false_type is_array_ptr_soft_impl( ... );
+
+		// array_element has no "type" for a non-array pointer, so array_element_t is SFINAE friendly.
+		template < typename T >
+		struct array_element_holder { using type = T; };
+
+		struct no_array_element {};
+
+		template < typename T, typename Dx >
+		array_element_holder< T > array_element_impl( std::unique_ptr< T[], Dx >* );
+		template < typename T >
+		array_element_holder< T > array_element_impl( std::shared_ptr< T[] >* );
+		no_array_element array_element_impl( ... );
+	}
+
+	template < typename T >
+	using is_array_ptr = detail::is_array_ptr_impl< detail::remove_cvr_t< T > >;
+
+	template < typename T >
+	constexpr bool is_array_ptr_v = is_array_ptr< T >::value;
+
+	template < typename T >
+	using is_array_ptr_soft = decltype( detail::is_array_ptr_soft_impl( std::declval< detail::remove_cvr_t< T >* >() ) );
+
+	template < typename T >
+	constexpr bool is_array_ptr_soft_v = is_array_ptr_soft< T >::value;
+
+	// detects inheritance too, like the soft version type traits.
+	template < typename T >
+	using array_element = decltype( detail::array_element_impl( std::declval< detail::remove_cvr_t< T >* >() ) );
+
+	template < typename T >
+	using array_element_t = typename array_element< T >::type;
+
+	// array pointer type trait end ==========================================================
+
 	// =======================================================================================
 	// united type trait ( all pointable classes )
 	// =======================================================================================
@@ -254,6 +320,288 @@ namespace woon2
 
 	// method trait end ======================================================================
 
+	// =======================================================================================
+	// ownership overhead trait
+	// A unique_ptr with a function pointer or stateful deleter is twice a raw pointer,
+	// and so is every shared_ptr, which also points to a control block.
+	// =======================================================================================
+	namespace detail
+	{
+		// an empty deleter costs nothing, unique_ptr stores it with the empty base optimization.
+		// a reference deleter is stored as a pointer, however empty the referred deleter is.
+		template < typename Dx >
+		using stored_deleter_size = std::integral_constant< std::size_t,
+			std::is_reference< Dx >::value
+				? sizeof( void* )
+				: ( std::is_empty< std::remove_reference_t< Dx > >::value ? 0 : sizeof( std::remove_reference_t< Dx > ) )
+			>;
+
+		struct not_unique_ptr_deleter {};
+
+		// measures the Dx unique_ptr stores, not what get_deleter() returns. ( Dx& for both Dx and Dx& )
+		template < typename T, typename Dx >
+		stored_deleter_size< Dx > deleter_size_soft_impl( std::unique_ptr< T, Dx >* );
+		not_unique_ptr_deleter deleter_size_soft_impl( ... );
+
+		// other pointer classes only tell the deleter through get_deleter().
+		template < typename T >
+		using returned_deleter_size = stored_deleter_size< remove_cvr_t< decltype( std::declval< T& >().get_deleter() ) > >;
+
+		template < typename T, bool = has_get_deleter_v< T > >
+		struct deleter_size_impl : std::integral_constant< std::size_t, 0 > {};
+
+		template < typename T >
+		struct deleter_size_impl< T, true > : std::conditional_t<
+			std::is_same< decltype( deleter_size_soft_impl( std::declval< T* >() ) ), not_unique_ptr_deleter >::value,
+			returned_deleter_size< T >,
+			decltype( deleter_size_soft_impl( std::declval< T* >() ) )
+			> {};
+	}
+
+	template < typename T >
+	struct ownership_overhead
+	{
+		using pointer_type = detail::remove_cvr_t< T >;
+
+		// sizeof the pointer object itself.
+		static constexpr std::size_t handle_size = sizeof( pointer_type );
+
+		// bytes of deleter stored in the handle. a shared_ptr's deleter lives in its control block.
+		static constexpr std::size_t deleter_size = detail::deleter_size_impl< pointer_type >::value;
+
+		static constexpr bool has_control_block = is_shared_ptr_soft_v< pointer_type >;
+
+		// bytes beyond a raw pointer.
+		static constexpr std::size_t overhead = handle_size > sizeof( void* ) ? handle_size - sizeof( void* ) : 0;
+	};
+
+	template < typename T >
+	constexpr std::size_t ownership_overhead< T >::handle_size;
+
+	template < typename T >
+	constexpr std::size_t ownership_overhead< T >::deleter_size;
+
+	template < typename T >
+	constexpr bool ownership_overhead< T >::has_control_block;
+
+	template < typename T >
+	constexpr std::size_t ownership_overhead< T >::overhead;
+
+	template < typename T >
+	using is_zero_overhead = std::integral_constant< bool,
+		ownership_overhead< T >::overhead == 0 && !ownership_overhead< T >::has_control_block
+		>;
+
+	template < typename T >
+	constexpr bool is_zero_overhead_v = is_zero_overhead< T >::value;
+
+	namespace detail
+	{
+		// a static_assert per cause, the failing type shows up in the instantiation context.
+		template < typename T >
+		struct zero_overhead_check
+		{
+			static_assert( !ownership_overhead< T >::has_control_block,
+				"assert_zero_overhead< T >(): T has a control block. ( shared_ptr is never as small as a raw pointer. )" );
+			static_assert( ownership_overhead< T >::deleter_size == 0,
+				"assert_zero_overhead< T >(): T stores its deleter. ( use an empty deleter instead of a function pointer, a capturing one, or a reference. )" );
+			static_assert( ownership_overhead< T >::overhead == 0,
+				"assert_zero_overhead< T >(): T is bigger than a raw pointer." );
+
+			static constexpr bool value = true;
+		};
+
+		template < bool ... Bs >
+		struct bool_list {};
+
+		template < bool ... Bs >
+		using all_true = std::is_same< bool_list< true, Bs... >, bool_list< Bs..., true > >;
+	}
+
+	// fails to compile unless every T is as small as a raw pointer, e.g.
+	// static_assert( woon2::assert_zero_overhead< std::unique_ptr< int >, std::unique_ptr< float[] > >(), "" );
+	template < typename ... Ts >
+	constexpr bool assert_zero_overhead() noexcept
+	{
+		return detail::all_true< detail::zero_overhead_check< Ts >::value... >::value;
+	}
+
+	// ownership overhead trait end ==========================================================
+
+	// =======================================================================================
+	// aligned array utilities
+	// aligned_span< T, Align > is a non-owning view whose data() promises Align to the compiler.
+	// what lets a loop vectorize is mostly ruling out aliasing ( __restrict ), the alignment rarely changes the code.
+	// make_unique_aligned< T[] > allocates an array on an Align boundary,
+	// and as_span( p, n ) picks the alignment up from its deleter.
+	// =======================================================================================
+
+	// a cache line, and a full AVX-512 register.
+	constexpr std::size_t default_simd_alignment = 64;
+
+	namespace detail
+	{
+		constexpr bool is_power_of_two( std::size_t n ) noexcept
+		{
+			return n != 0 && ( n & ( n - 1 ) ) == 0;
+		}
+
+		template < std::size_t Align, typename T >
+		inline T* assume_aligned( T* ptr ) noexcept
+		{
+#if defined( __GNUC__ ) || defined( __clang__ )
+			return static_cast< T* >( __builtin_assume_aligned( ptr, Align ) );
+#else
+			return ptr;
+#endif
+		}
+
+		// over-allocates, and stashes the address from malloc right before the aligned block.
+		inline void* aligned_malloc( std::size_t bytes, std::size_t align )
+		{
+			const std::size_t extra = align - 1 + sizeof( void* );
+			if ( bytes > std::numeric_limits< std::size_t >::max() - extra ) throw std::bad_alloc{};
+
+			void* raw = std::malloc( bytes + extra );
+			if ( !raw ) throw std::bad_alloc{};
+
+			const auto addr = ( reinterpret_cast< std::uintptr_t >( raw ) + extra ) & ~( static_cast< std::uintptr_t >( align ) - 1 );
+			void* aligned = reinterpret_cast< void* >( addr );
+			static_cast< void** >( aligned )[ -1 ] = raw;
+			return aligned;
+		}
+
+		inline void aligned_free( const void* ptr ) noexcept
+		{
+			if ( ptr ) std::free( static_cast< void* const* >( ptr )[ -1 ] );
+		}
+
+		// the stashed address needs at least a pointer's alignment.
+		template < std::size_t Align >
+		using storage_alignment = std::integral_constant< std::size_t, ( Align < alignof( void* ) ? alignof( void* ) : Align ) >;
+	}
+
+	// stateless, so unique_ptr< T[], aligned_delete< T, Align > > stays as small as a raw pointer.
+	// elements must be trivially destructible, the deleter doesn't know the length.
+	template < typename T, std::size_t Align >
+	struct aligned_delete
+	{
+		static_assert( detail::is_power_of_two( Align ), "aligned_delete< T, Align >: Align must be a power of two." );
+		static_assert( std::is_trivially_destructible< T >::value,
+			"aligned_delete< T, Align >: the deleter doesn't know the length to destroy elements, T must be trivially destructible." );
+
+		void operator()( T* ptr ) const noexcept
+		{
+			detail::aligned_free( ptr );
+		}
+	};
+
+	template < typename T, std::size_t Align = alignof( T ) >
+	class aligned_span
+	{
+		static_assert( detail::is_power_of_two( Align ), "aligned_span< T, Align >: Align must be a power of two." );
+		static_assert( Align >= alignof( T ), "aligned_span< T, Align >: Align must not be weaker than alignof( T )." );
+
+	public:
+		using element_type = T;
+		using value_type = std::remove_cv_t< T >;
+		using size_type = std::size_t;
+		using pointer = T*;
+		using reference = T&;
+		using iterator = T*;
+
+		static constexpr std::size_t alignment = Align;
+
+		constexpr aligned_span() noexcept : ptr{ nullptr }, n{ 0 } {}
+		aligned_span( T* first, std::size_t count ) noexcept : ptr{ first }, n{ count }
+		{
+			assert( reinterpret_cast< std::uintptr_t >( first ) % Align == 0 && "aligned_span: pointer is not aligned as promised." );
+		}
+
+		// aligned_span< U > to aligned_span< const U >, like T* to const T*.
+		template < typename U, typename = std::enable_if_t< std::is_same< const U, T >::value && !std::is_const< U >::value > >
+		aligned_span( const aligned_span< U, Align >& other ) noexcept : ptr{ other.data() }, n{ other.size() } {}
+
+		T* data() const noexcept { return detail::assume_aligned< Align >( ptr ); }
+		std::size_t size() const noexcept { return n; }
+		std::size_t size_bytes() const noexcept { return n * sizeof( T ); }
+		bool empty() const noexcept { return n == 0; }
+
+		T& operator[]( std::size_t idx ) const noexcept { return data()[ idx ]; }
+		iterator begin() const noexcept { return data(); }
+		iterator end() const noexcept { return data() + n; }
+
+	private:
+		T* ptr;
+		std::size_t n;
+	};
+
+	template < typename T, std::size_t Align >
+	constexpr std::size_t aligned_span< T, Align >::alignment;
+
+	namespace detail
+	{
+		// the alignment an array pointer guarantees. aligned_delete records a stronger one.
+		template < typename T, std::size_t Align >
+		std::integral_constant< std::size_t, Align > array_alignment_impl( std::unique_ptr< T[], aligned_delete< T, Align > >* );
+		template < typename T, typename Dx >
+		std::integral_constant< std::size_t, alignof( T ) > array_alignment_impl( std::unique_ptr< T[], Dx >* );
+		template < typename T >
+		std::integral_constant< std::size_t, alignof( T ) > array_alignment_impl( std::shared_ptr< T[] >* );
+	}
+
+	template < typename T >
+	using array_alignment = decltype( detail::array_alignment_impl( std::declval< detail::remove_cvr_t< T >* >() ) );
+
+	template < typename T >
+	constexpr std::size_t array_alignment_v = array_alignment< T >::value;
+
+	// n is the number of elements owned by p, smart pointers don't keep it.
+	template < typename Ptr >
+	aligned_span< array_element_t< Ptr >, array_alignment_v< Ptr > > as_span( const Ptr& p, std::size_t n ) noexcept
+	{
+		return { p.get(), n };
+	}
+
+	// promises Align explicitly, e.g. for a buffer from another aligned allocator.
+	template < std::size_t Align, typename Ptr >
+	aligned_span< array_element_t< Ptr >, Align > as_span( const Ptr& p, std::size_t n ) noexcept
+	{
+		return { p.get(), n };
+	}
+
+	// like std::make_unique< T[] >( n ), elements are value-initialized.
+	template < typename T, std::size_t Align = default_simd_alignment >
+	std::enable_if_t<
+		std::is_array< T >::value && std::extent< T >::value == 0,
+		std::unique_ptr< T, aligned_delete< std::remove_extent_t< T >, Align > >
+		>
+	make_unique_aligned( std::size_t n )
+	{
+		using elem_t = std::remove_extent_t< T >;
+
+		static_assert( Align >= alignof( elem_t ), "make_unique_aligned< T[] >(): Align must not be weaker than alignof( T )." );
+
+		if ( n > std::numeric_limits< std::size_t >::max() / sizeof( elem_t ) ) throw std::bad_alloc{};
+
+		// constructs through the raw storage, so a const elem_t works like with std::make_unique< const T[] >.
+		auto raw = static_cast< unsigned char* >( detail::aligned_malloc( n * sizeof( elem_t ), detail::storage_alignment< Align >::value ) );
+
+		try
+		{
+			for ( std::size_t i = 0; i < n; ++i ) ::new ( static_cast< void* >( raw + i * sizeof( elem_t ) ) ) std::remove_cv_t< elem_t >();
+		}
+		catch ( ... )
+		{
+			detail::aligned_free( raw );
+			throw;
+		}
+
+		return std::unique_ptr< T, aligned_delete< elem_t, Align > >{ reinterpret_cast< elem_t* >( raw ) };
+	}
+
+	// aligned array utilities end ===========================================================
+
 	// =======================================================================================
 	// Additional pointer type trait
 	// You can add your own pointer class's type trait.